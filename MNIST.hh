@@ -9,6 +9,7 @@
 #include <vector>
 #include <functional>
 #include <algorithm>
+#include <bit>
 
 #include "byte_swap.hh"
 
@@ -0,0 +1,554 @@
+//  Benchmark suite of ymd_util
+//
+//  Each ymd facility is measured against a hand-written loop doing the same work
+//  at several data sizes, and the ratio (ymd / raw) is printed.
+//
+//  Usage       : ymd_benchmark [--quick] [--perf] [--filter SUBSTRING]
+//                              [--baseline FILE] [--threshold PERCENT]
+//                              [--save-baseline FILE] [--csv FILE] [--json FILE]
+//
+//                --baseline compares the median of each benchmark with FILE (CSV
+//                written by --save-baseline or --csv) and exits with 1 when any of
+//                them is slower by more than --threshold percent (default 10).
+//
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Adam.hh"
+#include "MNIST.hh"
+#include "benchmark.hh"
+#include "byte_swap.hh"
+#include "index_iterator.hh"
+#include "parallel_for_each.hh"
+#include "profiler.hh"
+#include "sliding_window.hh"
+#include "soa_vector.hh"
+#include "transform_iterator.hh"
+#include "tuple_zip.hh"
+#include "zip.hh"
+
+namespace {
+  struct options {
+    ymd::benchmark_options bench;
+    bool quick = false;
+    std::string filter;
+    std::string baseline;
+    std::string save_baseline;
+    std::string csv;
+    std::string json;
+    double threshold = 10.0;
+  };
+
+  class suite {
+  private:
+    const options& opt;
+    std::vector<ymd::benchmark_result> results;
+
+    bool selected(const std::string& group) const {
+      return opt.filter.empty() || group.find(opt.filter) != std::string::npos;
+    }
+
+    template<typename F>
+    const ymd::benchmark_result& run(std::string name,F&& f,double bytes){
+      results.push_back(ymd::benchmark(std::move(name),std::forward<F>(f),opt.bench));
+      auto& r = results.back();
+      std::cout << r;
+      if(bytes > 0){ std::cout << ", " << bytes / r.median << " GB/s"; }
+      std::cout << std::endl;
+      return r;
+    }
+
+  public:
+    suite(const options& opt): opt(opt), results{} {}
+
+    // Measure ymd_f and raw_f, which must do the same work on n elements.
+    template<typename F,typename G>
+    void compare(const std::string& group,std::size_t n,F&& ymd_f,G&& raw_f,
+		 double bytes = 0){
+      if(!selected(group)){ return; }
+
+      auto suffix = std::string{"/"} + std::to_string(n);
+      auto& y = run(group + "/ymd" + suffix,std::forward<F>(ymd_f),bytes);
+      auto y_median = y.median;
+      auto& r = run(group + "/raw" + suffix,std::forward<G>(raw_f),bytes);
+      std::cout << "  => ymd / raw = " << y_median / r.median << std::endl;
+    }
+
+    const std::vector<ymd::benchmark_result>& get() const { return results; }
+  };
+
+  auto random_vector(std::size_t n,std::uint32_t seed = 0){
+    auto g = std::mt19937{seed};
+    auto d = std::uniform_real_distribution<double>{-1.0,1.0};
+    auto v = std::vector<double>{};
+    v.reserve(n);
+    std::generate_n(std::back_inserter(v),n,[&](){ return d(g); });
+    return v;
+  }
+
+  void zip_benchmark(suite& s,std::size_t n){
+    auto a = random_vector(n,1);
+    auto b = random_vector(n,2);
+
+    s.compare("zip",n,
+	      [&](){
+		double sum = 0.0;
+		for(auto&& [x,y] : ymd::zip(a,b)){ sum += x * y; }
+		return sum;
+	      },
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; ++i){ sum += a[i] * b[i]; }
+		return sum;
+	      },
+	      2.0 * n * sizeof(double));
+  }
+
+  void transform_benchmark(suite& s,std::size_t n){
+    auto a = random_vector(n);
+
+    s.compare("transform",n,
+	      [&](){
+		double sum = 0.0;
+		for(auto x : ymd::transform(a,[](double v){ return 2.0 * v + 1.0; })){
+		  sum += x;
+		}
+		return sum;
+	      },
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; ++i){ sum += 2.0 * a[i] + 1.0; }
+		return sum;
+	      },
+	      1.0 * n * sizeof(double));
+  }
+
+  void shuffle_view_benchmark(suite& s,std::size_t n){
+    auto a = random_vector(n);
+
+    auto view = ymd::shuffle_view(a,std::mt19937{3});
+
+    auto indexes = std::vector<std::size_t>(n);
+    std::iota(indexes.begin(),indexes.end(),0);
+    std::shuffle(indexes.begin(),indexes.end(),std::mt19937{3});
+
+    s.compare("shuffle_view",n,
+	      [&](){
+		double sum = 0.0;
+		for(auto x : view){ sum += x; }
+		return sum;
+	      },
+	      [&](){
+		double sum = 0.0;
+		for(auto i : indexes){ sum += a[i]; }
+		return sum;
+	      },
+	      1.0 * n * (sizeof(double) + sizeof(std::size_t)));
+  }
+
+  void sliding_window_benchmark(suite& s,std::size_t n){
+    constexpr std::size_t window = 16;
+    auto a = random_vector(n);
+
+    s.compare("sliding_window",n,
+	      [&](){
+		double max = 0.0;
+		for(auto&& w : ymd::sliding_window(a,window,1)){
+		  double sum = 0.0;
+		  for(auto x : w){ sum += x; }
+		  max = std::max(max,sum);
+		}
+		return max;
+	      },
+	      [&](){
+		double max = 0.0;
+		for(auto i = 0ul; i + window <= n; ++i){
+		  double sum = 0.0;
+		  for(auto j = i; j < i + window; ++j){ sum += a[j]; }
+		  max = std::max(max,sum);
+		}
+		return max;
+	      });
+  }
+
+  void MNIST_benchmark(suite& s,std::size_t n_images){
+    constexpr std::uint32_t rows = 28, columns = 28;
+    auto filename = (std::filesystem::temp_directory_path() /
+		     ("ymd_benchmark_" + std::to_string(n_images) + ".idx3")).string();
+
+    {
+      auto write32 = [](std::ofstream& ofs,std::uint32_t v){
+		       v = ymd::swap32(v);
+		       if(std::endian::big == std::endian::native){ v = ymd::swap32(v); }
+		       ofs.write((const char*)&v,sizeof(v));
+		     };
+      auto ofs = std::ofstream{filename,std::ios::out | std::ios::binary};
+      write32(ofs,2051);
+      write32(ofs,std::uint32_t(n_images));
+      write32(ofs,rows);
+      write32(ofs,columns);
+
+      auto g = std::mt19937{4};
+      auto pixels = std::vector<char>(n_images * rows * columns);
+      std::generate(pixels.begin(),pixels.end(),[&](){ return char(g()); });
+      ofs.write(pixels.data(),std::streamsize(pixels.size()));
+    }
+
+    const auto pixels = std::size_t(rows * columns);
+    s.compare("read_MNIST",n_images,
+	      [&](){ return ymd::read_MNIST(filename).size(); },
+	      [&](){
+		auto ifs = std::ifstream{filename,std::ios::in | std::ios::binary};
+		ifs.seekg(16);
+		auto buffer = std::vector<unsigned char>(n_images * pixels);
+		ifs.read((char*)buffer.data(),std::streamsize(buffer.size()));
+
+		auto data = std::vector<std::vector<double>>(n_images);
+		for(auto i = 0ul; i < n_images; ++i){
+		  data[i].resize(pixels);
+		  for(auto j = 0ul; j < pixels; ++j){
+		    data[i][j] = (buffer[i*pixels + j] - 128) / 128.0;
+		  }
+		}
+		return data.size();
+	      },
+	      1.0 * n_images * pixels);
+
+    auto data = ymd::read_MNIST(filename);
+    auto bytes = sizeof(data) + data.capacity() * sizeof(data[0]);
+    for(auto& image : data){ bytes += image.capacity() * sizeof(image[0]); }
+    std::cout << "  read_MNIST memory: " << bytes / 1e6 << " MB for "
+	      << data.size() << " images (file: " << (16 + n_images * pixels) / 1e6
+	      << " MB)" << std::endl;
+
+    std::filesystem::remove(filename);
+  }
+
+  void Adam_benchmark(suite& s,std::size_t n){
+    auto p1 = random_vector(n,5);
+    auto p2 = p1;
+    auto g = random_vector(n,6);
+
+    auto opts = std::vector<ymd::Adam<double>>(n);
+
+    auto m = std::vector<double>(n,0.0);
+    auto v = std::vector<double>(n,0.0);
+    double beta1_t = 0.0, beta2_t = 0.0;
+
+    s.compare("Adam",n,
+	      [&](){
+		for(auto&& [p,d,adam] : ymd::zip(p1,g,opts)){ p -= adam(d); }
+		return p1.data();
+	      },
+	      [&](){
+		constexpr double alpha = 0.001, beta1 = 0.9, beta2 = 0.999, eps = 1e-8;
+		beta1_t *= beta1;
+		beta2_t *= beta2;
+		for(auto i = 0ul; i < n; ++i){
+		  m[i] = beta1 * m[i] + (1-beta1) * g[i];
+		  v[i] = beta2 * v[i] + (1-beta2) * g[i] * g[i];
+		  auto m_hat = m[i] / (1-beta1_t);
+		  auto v_hat = v[i] / (1-beta2_t);
+		  p2[i] -= alpha * m_hat / (std::sqrt(v_hat) + eps);
+		}
+		return p2.data();
+	      },
+	      1.0 * n * 4 * sizeof(double));
+  }
+
+  void byte_swap_benchmark(suite& s,std::size_t n){
+    auto a = std::vector<std::uint32_t>(n);
+    std::iota(a.begin(),a.end(),0u);
+
+    s.compare("byte_swap",n,
+	      [&](){
+		for(auto& x : a){ x = ymd::swap32(x); }
+		return a.data();
+	      },
+	      [&](){
+		for(auto& x : a){
+#if defined(__GNUC__) || defined(__clang__)
+		  x = __builtin_bswap32(x);
+#else
+		  x = (x << 24) | ((x << 8) & 0x00FF0000) | ((x >> 8) & 0x0000FF00) | (x >> 24);
+#endif
+		}
+		return a.data();
+	      },
+	      2.0 * n * sizeof(std::uint32_t));
+  }
+
+  void tuple_zip_benchmark(suite& s,std::size_t n){
+    auto a = std::vector<std::array<double,16>>(n);
+    auto b = std::vector<std::array<double,16>>(n);
+    auto g = std::mt19937{7};
+    auto d = std::uniform_real_distribution<double>{-1.0,1.0};
+    for(auto& x : a){ for(auto& e : x){ e = d(g); } }
+    for(auto& x : b){ for(auto& e : x){ e = d(g); } }
+
+    s.compare("tuple_zip_dot16",n,
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; ++i){ sum += ymd::dot(a[i],b[i]); }
+		return sum;
+	      },
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; ++i){
+		  double dot = 0.0;
+		  for(auto j = 0ul; j < 16; ++j){ dot += a[i][j] * b[i][j]; }
+		  sum += dot;
+		}
+		return sum;
+	      },
+	      2.0 * n * sizeof(a[0]));
+  }
+
+  void soa_vector_benchmark(suite& s,std::size_t n){
+    struct particle { double x, y, z, vx, vy, vz; };
+    auto aos = std::vector<particle>(n);
+    auto soa = ymd::soa_vector<double,double,double,double,double,double>{};
+    soa.reserve(n);
+    auto p = random_vector(n);
+    for(auto i = 0ul; i < n; ++i){
+      aos[i] = particle{p[i],p[i],p[i],1.0,1.0,1.0};
+      soa.push_back(p[i],p[i],p[i],1.0,1.0,1.0);
+    }
+
+    // Only x and vx are touched, which is where the column layout pays off.
+    s.compare("soa_vector_vs_aos",n,
+	      [&](){
+		auto x = soa.data<0>();
+		auto vx = soa.data<3>();
+		for(auto i = 0ul; i < n; ++i){ x[i] += 0.01 * vx[i]; }
+		return x;
+	      },
+	      [&](){
+		for(auto& q : aos){ q.x += 0.01 * q.vx; }
+		return aos.data();
+	      });
+  }
+
+  void parallel_for_each_benchmark(suite& s,std::size_t n){
+    auto a = random_vector(n,8);
+    auto b = random_vector(n,9);
+
+    s.compare("parallel_for_each",n,
+	      [&](){
+		ymd::parallel_for_each(ymd::zip(a,b),
+				       [](auto&& t){
+					 auto&& [x,y] = t;
+					 x = std::sqrt(x * x + y * y);
+				       },
+				       4096);
+		return a.data();
+	      },
+	      [&](){
+		for(auto i = 0ul; i < n; ++i){ a[i] = std::sqrt(a[i] * a[i] + b[i] * b[i]); }
+		return a.data();
+	      });
+
+    // Zipped index view: SGD-like update of a through a shuffled view.
+    auto c = random_vector(n,3);
+    auto view = ymd::shuffle_view(a,std::mt19937{10});
+    auto indexes = std::vector<std::size_t>(n);
+    std::iota(indexes.begin(),indexes.end(),0);
+    std::shuffle(indexes.begin(),indexes.end(),std::mt19937{10});
+
+    s.compare("parallel_for_each_shuffle_zip",n,
+	      [&](){
+		ymd::parallel_for_each(ymd::zip(view,c),
+				       [](auto&& t){
+					 auto&& [x,y] = t;
+					 x -= 0.01 * y;
+				       },
+				       4096);
+		return a.data();
+	      },
+	      [&](){
+		for(auto i = 0ul; i < n; ++i){ a[indexes[i]] -= 0.01 * c[i]; }
+		return a.data();
+	      });
+  }
+
+  void profiler_benchmark(suite& s,std::size_t n){
+    auto a = random_vector(n);
+
+    s.compare("profiler_scope",n,
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; i += 64){
+		  ymd::scope_timer t{"benchmark"};
+		  for(auto j = i; j < std::min(i + 64,n); ++j){ sum += a[j]; }
+		}
+		return sum;
+	      },
+	      [&](){
+		double sum = 0.0;
+		for(auto i = 0ul; i < n; i += 64){
+		  for(auto j = i; j < std::min(i + 64,n); ++j){ sum += a[j]; }
+		}
+		return sum;
+	      });
+  }
+
+  // Median of each benchmark in a CSV written by ymd::write_csv
+  std::map<std::string,double> read_baseline(const std::string& filename){
+    auto medians = std::map<std::string,double>{};
+    auto ifs = std::ifstream{filename};
+    if(!ifs.is_open()){ return medians; }
+
+    std::string line;
+    std::getline(ifs,line); // header
+    while(std::getline(ifs,line)){
+      if(line.empty() || line[0] != '"'){ continue; }
+
+      std::string name{};
+      auto i = 1ul;
+      for(; i < line.size(); ++i){
+	if(line[i] == '"'){
+	  if(i + 1 < line.size() && line[i+1] == '"'){ name += '"'; ++i; continue; }
+	  break;
+	}
+	name += line[i];
+      }
+
+      // name,iterations,samples,min_ns,median_ns,...
+      auto fields = std::vector<std::string>{};
+      std::stringstream rest{line.substr(std::min(i + 2,line.size()))};
+      for(std::string field; std::getline(rest,field,',');){ fields.push_back(field); }
+      if(fields.size() > 3){ medians[name] = std::stod(fields[3]); }
+    }
+
+    return medians;
+  }
+
+  bool check_regression(const std::vector<ymd::benchmark_result>& results,
+			const options& opt){
+    auto baseline = read_baseline(opt.baseline);
+    if(baseline.empty()){
+      std::cout << "\nNo baseline in " << opt.baseline << ", skip comparison" << std::endl;
+      return false;
+    }
+
+    bool regressed = false;
+    std::cout << "\nComparison with " << opt.baseline
+	      << " (threshold " << opt.threshold << "%)" << std::endl;
+    for(auto& r : results){
+      auto it = baseline.find(r.name);
+      if(it == baseline.end()){ continue; }
+
+      auto change = 100.0 * (r.median - it->second) / it->second;
+      auto is_regression = change > opt.threshold;
+      regressed = regressed || is_regression;
+      std::cout << (is_regression ? "REGRESSION " : "           ") << r.name << ": "
+		<< it->second << " ns -> " << r.median << " ns ("
+		<< (change > 0 ? "+" : "") << change << "%)" << std::endl;
+    }
+
+    return regressed;
+  }
+
+  options parse(int argc,char** argv){
+    auto opt = options{};
+    for(auto i = 1; i < argc; ++i){
+      auto arg = std::string{argv[i]};
+      auto value = [&](){
+		     if(i + 1 >= argc){
+		       std::cerr << "Missing value for " << arg << std::endl;
+		       std::exit(2);
+		     }
+		     return std::string{argv[++i]};
+		   };
+
+      if(arg == "--quick"){
+	opt.quick = true;
+      }else if(arg == "--perf"){
+	opt.bench.perf_counters = true;
+      }else if(arg == "--filter"){
+	opt.filter = value();
+      }else if(arg == "--baseline"){
+	opt.baseline = value();
+      }else if(arg == "--save-baseline"){
+	opt.save_baseline = value();
+      }else if(arg == "--threshold"){
+	opt.threshold = std::stod(value());
+      }else if(arg == "--csv"){
+	opt.csv = value();
+      }else if(arg == "--json"){
+	opt.json = value();
+      }else{
+	std::cerr << "Unknown option: " << arg << std::endl;
+	std::exit(2);
+      }
+    }
+
+    if(opt.quick){
+      opt.bench.warmup = std::chrono::milliseconds{5};
+      opt.bench.min_sample_time = std::chrono::milliseconds{1};
+      opt.bench.samples = 10;
+    }
+
+    return opt;
+  }
+} // namespace
+
+int main(int argc,char** argv){
+  auto opt = parse(argc,argv);
+  auto s = suite{opt};
+
+  const auto sizes = opt.quick ?
+    std::vector<std::size_t>{1ul << 10, 1ul << 16} :
+    std::vector<std::size_t>{1ul << 10, 1ul << 16, 1ul << 20};
+
+  for(auto n : sizes){
+    zip_benchmark(s,n);
+    transform_benchmark(s,n);
+    shuffle_view_benchmark(s,n);
+    sliding_window_benchmark(s,n);
+    Adam_benchmark(s,n);
+    byte_swap_benchmark(s,n);
+    tuple_zip_benchmark(s,n / 16);
+    soa_vector_benchmark(s,n);
+    parallel_for_each_benchmark(s,n);
+    profiler_benchmark(s,n);
+  }
+
+  const auto n_images = opt.quick ?
+    std::vector<std::size_t>{100} :
+    std::vector<std::size_t>{100, 1000, 10000};
+  for(auto n : n_images){ MNIST_benchmark(s,n); }
+
+  auto& results = s.get();
+  if(!opt.csv.empty()){
+    auto ofs = std::ofstream{opt.csv};
+    ymd::write_csv(ofs,results);
+  }
+  if(!opt.json.empty()){
+    auto ofs = std::ofstream{opt.json};
+    ymd::write_json(ofs,results);
+  }
+  if(!opt.save_baseline.empty()){
+    auto ofs = std::ofstream{opt.save_baseline};
+    ymd::write_csv(ofs,results);
+    std::cout << "\nBaseline saved to " << opt.save_baseline << std::endl;
+  }
+
+  if(!opt.baseline.empty() && check_regression(results,opt)){ return 1; }
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+#ifndef YMD_BENCHMARK_HH
+#define YMD_BENCHMARK_HH 1
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <utility>
+
+#include "timer.hh"
+#include "perf_counter.hh"
+
+//  Requirement: c++17
+//
+//  Function   : template<typename F>
+//               auto benchmark(std::string name,F f,benchmark_options opt = {})
+//               Arguments
+//               ---------
+//               std::string name      : Name reported in the result
+//               F f                   : Function object measured. Its return value
+//                                       is passed to do_not_optimize.
+//               benchmark_options opt : Warm-up time, sample time, sample count and
+//                                       whether to read ymd::perf_counters
+//
+//               Return
+//               ------
+//               benchmark_result: Statistics of nanoseconds per iteration
+//
+//               f is first called in growing batches until a batch takes at least
+//               opt.min_sample_time (calibration), and then for opt.warmup.
+//               Finally opt.samples batches of the calibrated size are timed with
+//               std::chrono::steady_clock.
+//
+//               When opt.perf_counters is true, hardware counters are enabled over
+//               all the samples and reported per iteration in result.counters.
+//               If the counters can't be opened, counters is just left empty.
+//
+//  Usage       : auto r = ymd::benchmark("sum",[&](){ return std::accumulate(...); });
+//                std::cout << r << std::endl;
+//                ymd::write_csv(std::cout,{r});
+//
+
+namespace ymd {
+  struct benchmark_options {
+    std::chrono::nanoseconds warmup = std::chrono::milliseconds{50};
+    std::chrono::nanoseconds min_sample_time = std::chrono::milliseconds{5};
+    std::size_t samples = 30;
+    std::size_t max_iterations = std::size_t{1} << 30;
+    bool perf_counters = false;
+  };
+
+  struct benchmark_result {
+    std::string name;
+    std::size_t iterations; // per sample
+    std::vector<double> samples; // ns per iteration
+    double min;
+    double median;
+    double mean;
+    double stddev;
+    double p99;
+    std::vector<std::pair<std::string,double>> counters; // per iteration
+
+    static std::string csv_header(){
+      auto header = std::string{"name,iterations,samples,"
+				"min_ns,median_ns,mean_ns,stddev_ns,p99_ns"};
+      for(auto name : perf_counters::names){ header += std::string{","} + name; }
+      return header;
+    }
+
+    // Counter per iteration, or NaN if it wasn't measured
+    double counter(const std::string& counter_name) const {
+      for(auto& [name,value] : counters){
+	if(name == counter_name){ return value; }
+      }
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+
+    std::string csv() const {
+      std::ostringstream os{};
+      os << std::setprecision(6) << '"';
+      for(auto c : name){
+	if(c == '"'){ os << '"'; }
+	os << c;
+      }
+      os << '"' << ',' << iterations << ',' << samples.size() << ','
+	 << min << ',' << median << ',' << mean << ',' << stddev << ',' << p99;
+      for(auto name : perf_counters::names){
+	os << ',';
+	if(auto v = counter(name); !std::isnan(v)){ os << v; }
+      }
+      return os.str();
+    }
+
+    std::string json() const {
+      std::ostringstream os{};
+      os << std::setprecision(6) << "{\"name\":\"";
+      for(auto c : name){
+	if(c == '"' || c == '\\'){ os << '\\'; }
+	os << c;
+      }
+      os << "\",\"iterations\":" << iterations
+	 << ",\"samples\":" << samples.size()
+	 << ",\"min_ns\":" << min
+	 << ",\"median_ns\":" << median
+	 << ",\"mean_ns\":" << mean
+	 << ",\"stddev_ns\":" << stddev
+	 << ",\"p99_ns\":" << p99;
+      for(auto& [name,value] : counters){ os << ",\"" << name << "\":" << value; }
+      os << "}";
+      return os.str();
+    }
+
+    friend inline std::ostream& operator<<(std::ostream& os,const benchmark_result& r){
+      os << r.name << ": "
+	 << "median " << r.median << " ns, "
+	 << "mean " << r.mean << " +- " << r.stddev << " ns, "
+	 << "min " << r.min << " ns, "
+	 << "p99 " << r.p99 << " ns "
+	 << "(" << r.samples.size() << " x " << r.iterations << " iterations)";
+      for(auto& [name,value] : r.counters){ os << ", " << name << " " << value; }
+      return os;
+    }
+  };
+
+  inline void write_csv(std::ostream& os,const std::vector<benchmark_result>& results){
+    os << benchmark_result::csv_header() << "\n";
+    for(auto& r : results){ os << r.csv() << "\n"; }
+  }
+
+  inline void write_json(std::ostream& os,const std::vector<benchmark_result>& results){
+    os << "[";
+    for(auto i = 0ul; i < results.size(); ++i){
+      os << (i ? ",\n " : "") << results[i].json();
+    }
+    os << "]\n";
+  }
+
+  namespace detail {
+    template<typename F>
+    inline std::chrono::nanoseconds time_batch(F& f,std::size_t iterations){
+      using namespace std::chrono;
+
+      auto start = steady_clock::now();
+      for(auto i = 0ul; i < iterations; ++i){
+	invoke_kept(f);
+      }
+      auto end = steady_clock::now();
+
+      return duration_cast<nanoseconds>(end - start);
+    }
+
+    // Smallest batch size taking at least opt.min_sample_time
+    template<typename F>
+    inline std::size_t calibrate(F& f,const benchmark_options& opt){
+      std::size_t iterations = 1;
+      while(iterations < opt.max_iterations){
+	auto t = time_batch(f,iterations).count();
+	if(t >= opt.min_sample_time.count()){ break; }
+
+	// Aim slightly above the target, but grow at most 10 times per step.
+	auto estimate = (t > 0) ?
+	  1.2 * iterations * opt.min_sample_time.count() / t :
+	  10.0 * iterations;
+	iterations = std::min({std::max(2*iterations,std::size_t(estimate)),
+			       10*iterations,
+			       opt.max_iterations});
+      }
+      return iterations;
+    }
+
+    inline void summarize(benchmark_result& r){
+      auto sorted = r.samples;
+      std::sort(sorted.begin(),sorted.end());
+      auto n = sorted.size();
+      if(!n){ return; }
+
+      r.min = sorted.front();
+      r.median = (n % 2) ? sorted[n/2] : 0.5 * (sorted[n/2 - 1] + sorted[n/2]);
+      r.mean = std::accumulate(sorted.begin(),sorted.end(),0.0) / n;
+
+      auto sq = std::accumulate(sorted.begin(),sorted.end(),0.0,
+				[m = r.mean](double acc,double v){
+				  return acc + (v - m) * (v - m);
+				});
+      r.stddev = (n > 1) ? std::sqrt(sq / (n - 1)) : 0.0;
+
+      // Nearest-rank percentile
+      auto rank = std::size_t(std::ceil(0.99 * n));
+      r.p99 = sorted[std::max(rank,std::size_t{1}) - 1];
+    }
+  } // namespace detail
+
+  template<typename F>
+  inline auto benchmark(std::string name,F f,benchmark_options opt = {}){
+    using namespace std::chrono;
+
+    auto iterations = detail::calibrate(f,opt);
+
+    auto warmup_end = steady_clock::now() + opt.warmup;
+    while(steady_clock::now() < warmup_end){
+      detail::time_batch(f,iterations);
+    }
+
+    auto r = benchmark_result{std::move(name),iterations,{},0,0,0,0,0,{}};
+    r.samples.reserve(opt.samples);
+
+    auto pc = opt.perf_counters ? std::make_unique<perf_counters>() : nullptr;
+    if(pc){ pc->start(); }
+    for(auto i = 0ul; i < opt.samples; ++i){
+      auto t = detail::time_batch(f,iterations);
+      r.samples.push_back(double(t.count()) / iterations);
+    }
+    if(pc){
+      pc->stop();
+      r.counters = pc->read();
+      for(auto& c : r.counters){ c.second /= double(iterations * opt.samples); }
+    }
+    detail::summarize(r);
+
+    return r;
+  }
+} // namespace ymd
+#endif // YMD_BENCHMARK_HH
@@ -16,7 +16,8 @@ namespace ymd {
       ValueIterator v_it;
       IndexIterator i_it;
     public:
-      using iterator_category = std::input_iterator_tag;
+      using iterator_category =
+	typename std::iterator_traits<IndexIterator>::iterator_category;
       using difference_type = ptrdiff_t;
       using value_type = typename ValueIterator::value_type;
       using pointer = typename ValueIterator::pointer;
@@ -36,7 +37,30 @@ namespace ymd {
       auto& operator--(){ --i_it; return *this; }
       auto operator--(int){ auto copy{*this}; --(*this); return copy; }
 
-      auto operator*(){ return *std::next(v_it,*i_it); }
+      // Random access (only instantiated when IndexIterator is random access)
+      auto& operator+=(difference_type n){ i_it += n; return *this; }
+      auto& operator-=(difference_type n){ i_it -= n; return *this; }
+      decltype(auto) operator[](difference_type n) const { return *(*this + n); }
+
+      decltype(auto) operator*() const { return *std::next(v_it,*i_it); }
+
+      friend inline auto operator+(index_iterator<ValueIterator,IndexIterator> it,
+				   difference_type n){
+	return it += n;
+      }
+      friend inline auto operator+(difference_type n,
+				   index_iterator<ValueIterator,IndexIterator> it){
+	return it += n;
+      }
+      friend inline auto operator-(index_iterator<ValueIterator,IndexIterator> it,
+				   difference_type n){
+	return it -= n;
+      }
+      friend inline difference_type
+      operator-(const index_iterator<ValueIterator,IndexIterator>& lhs,
+		const index_iterator<ValueIterator,IndexIterator>& rhs){
+	return lhs.i_it - rhs.i_it;
+      }
 
       friend inline
       auto operator<(const index_iterator<ValueIterator,IndexIterator>& lhs,
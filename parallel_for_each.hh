@@ -0,0 +1,229 @@
+#ifndef YMD_PARALLEL_FOR_EACH_HH
+#define YMD_PARALLEL_FOR_EACH_HH 1
+
+#include <iterator>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+//  Requirement: c++17
+//
+//  Function   : template<typename Range,typename F>
+//               auto parallel_for_each(Range&& range,F f,std::size_t grain = 1024,
+//                                      thread_pool& pool = default_thread_pool())
+//               Arguments
+//               ---------
+//               Range&& range    : Container or ymd view (zip, index_view, soa_vector, ...)
+//               F f              : Function object called with each element.
+//                                  It must be safe to call concurrently.
+//               std::size_t grain: The number of elements in a chunk
+//               thread_pool& pool: Threads running the chunks
+//
+//               Return
+//               ------
+//               std::vector<ymd::worker_stats>: Load of each worker
+//
+//               The range is split into chunks of grain elements. Chunks are first
+//               dealt out to the workers in contiguous blocks, then idle workers
+//               steal chunks from the others, so that irregular per-element costs
+//               are still balanced. Ranges with random access iterators are split
+//               in O(1), others fall back to std::next.
+//
+//               Calling parallel_for_each from inside f on the same pool is not
+//               supported.
+//
+//  Usage       : ymd::parallel_for_each(ymd::zip(param,grad),
+//                                       [](auto&& t){
+//                                         auto&& [p,g] = t;
+//                                         p -= 0.01 * g;
+//                                       });
+//
+
+namespace ymd {
+  struct worker_stats {
+    std::size_t chunks;
+    std::size_t elements;
+    std::size_t steals;
+    std::chrono::nanoseconds busy;
+  };
+
+  class thread_pool {
+  private:
+    struct chunk_queue {
+      std::mutex m;
+      std::deque<std::size_t> chunks;
+    };
+
+    std::size_t n_workers;
+    std::vector<std::thread> threads;
+    std::unique_ptr<chunk_queue[]> queues;
+    std::vector<worker_stats> stats;
+
+    std::mutex run_m;
+    std::mutex m;
+    std::condition_variable cv_start;
+    std::condition_variable cv_done;
+    std::size_t generation;
+    std::size_t running;
+    bool stop;
+
+    std::function<std::size_t(std::size_t)> task;
+    std::exception_ptr error;
+
+    bool pop(std::size_t id,std::size_t& chunk){
+      std::lock_guard<std::mutex> lock{queues[id].m};
+      if(queues[id].chunks.empty()){ return false; }
+      chunk = queues[id].chunks.back();
+      queues[id].chunks.pop_back();
+      return true;
+    }
+
+    bool steal(std::size_t id,std::size_t& chunk){
+      for(auto i = 1ul; i < n_workers; ++i){
+	auto& victim = queues[(id + i) % n_workers];
+	std::lock_guard<std::mutex> lock{victim.m};
+	if(!victim.chunks.empty()){
+	  chunk = victim.chunks.front();
+	  victim.chunks.pop_front();
+	  return true;
+	}
+      }
+      return false;
+    }
+
+    void work(std::size_t id){
+      using namespace std::chrono;
+
+      auto& s = stats[id];
+      auto start = steady_clock::now();
+      std::size_t chunk;
+
+      while(true){
+	if(!pop(id,chunk)){
+	  if(!steal(id,chunk)){ break; }
+	  ++s.steals;
+	}
+
+	try {
+	  s.elements += task(chunk);
+	  ++s.chunks;
+	}catch(...){
+	  std::lock_guard<std::mutex> lock{m};
+	  if(!error){ error = std::current_exception(); }
+	}
+      }
+
+      s.busy = duration_cast<nanoseconds>(steady_clock::now() - start);
+    }
+
+    void loop(std::size_t id){
+      std::size_t seen = 0;
+      while(true){
+	{
+	  std::unique_lock<std::mutex> lock{m};
+	  cv_start.wait(lock,[&](){ return stop || generation != seen; });
+	  if(stop){ return; }
+	  seen = generation;
+	}
+
+	work(id);
+
+	std::lock_guard<std::mutex> lock{m};
+	if(--running == 0){ cv_done.notify_one(); }
+      }
+    }
+
+  public:
+    explicit thread_pool(std::size_t n = std::thread::hardware_concurrency())
+      : n_workers{std::max(n,std::size_t{1})},
+	queues{new chunk_queue[n_workers]}, stats(n_workers),
+	generation{0}, running{0}, stop{false} {
+      // The calling thread of run() works as the worker 0.
+      threads.reserve(n_workers - 1);
+      for(auto id = 1ul; id < n_workers; ++id){
+	threads.emplace_back([this,id](){ loop(id); });
+      }
+    }
+    thread_pool(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+    ~thread_pool(){
+      {
+	std::lock_guard<std::mutex> lock{m};
+	stop = true;
+      }
+      cv_start.notify_all();
+      for(auto& t : threads){ t.join(); }
+    }
+
+    std::size_t size() const { return n_workers; }
+
+    // Run f(chunk) for chunk in [0, n_chunks). f returns the number of processed
+    // elements, which is accumulated into the returned statistics.
+    template<typename F> auto run(std::size_t n_chunks,F&& f){
+      std::lock_guard<std::mutex> run_lock{run_m};
+
+      for(auto id = 0ul; id < n_workers; ++id){
+	auto first = n_chunks * id / n_workers;
+	auto last = n_chunks * (id + 1) / n_workers;
+	auto& q = queues[id].chunks;
+	for(auto c = first; c < last; ++c){ q.push_back(last - 1 - (c - first)); }
+	stats[id] = worker_stats{0,0,0,std::chrono::nanoseconds{0}};
+      }
+
+      {
+	std::lock_guard<std::mutex> lock{m};
+	task = std::forward<F>(f);
+	error = nullptr;
+	running = n_workers - 1;
+	++generation;
+      }
+      cv_start.notify_all();
+
+      work(0);
+
+      std::unique_lock<std::mutex> lock{m};
+      cv_done.wait(lock,[this](){ return running == 0; });
+      task = nullptr;
+      if(error){ std::rethrow_exception(std::exchange(error,nullptr)); }
+
+      return stats;
+    }
+  };
+
+  inline thread_pool& default_thread_pool(){
+    static thread_pool pool{};
+    return pool;
+  }
+
+  template<typename Range,typename F>
+  inline auto parallel_for_each(Range&& range,F f,std::size_t grain = 1024,
+				thread_pool& pool = default_thread_pool()){
+    using std::begin;
+    using std::end;
+
+    auto first = begin(range);
+    std::size_t size = std::distance(first,end(range));
+    grain = std::max(grain,std::size_t{1});
+
+    return pool.run((size + grain - 1) / grain,
+		    [=,&f](std::size_t chunk){
+		      auto c_begin = chunk * grain;
+		      auto c_end = std::min(c_begin + grain,size);
+
+		      auto it = std::next(first,c_begin);
+		      for(auto i = c_begin; i < c_end; ++i, ++it){ f(*it); }
+		      return c_end - c_begin;
+		    });
+  }
+} // namespace ymd
+#endif // YMD_PARALLEL_FOR_EACH_HH
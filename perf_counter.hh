@@ -0,0 +1,137 @@
+#ifndef YMD_PERF_COUNTER_HH
+#define YMD_PERF_COUNTER_HH 1
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+//  Requirement: c++17, Linux (perf_event_open) for actual counting
+//
+//  Class      : ymd::perf_counters
+//               Hardware/software performance counters of the calling thread
+//               (user space only): cycles, instructions, L1d read misses,
+//               LLC misses, branch misses and page faults.
+//
+//               Each event is opened independently, so events rejected by the
+//               kernel or the CPU are just skipped. When none can be opened
+//               (non Linux, perf_event_paranoid, container seccomp, ...),
+//               available() is false and start/stop/read are no-ops.
+//
+//               Counts are scaled by time_enabled/time_running when the kernel
+//               multiplexes the counters.
+//
+//  Usage       : ymd::perf_counters pc{};
+//                pc.start();
+//                f();
+//                pc.stop();
+//                for(auto& [name,count] : pc.read()){ ... }
+//
+
+namespace ymd {
+  class perf_counters {
+  public:
+    static constexpr std::array<const char*,6> names = {
+      "cycles","instructions","l1d_misses","llc_misses","branch_misses","page_faults"
+    };
+
+  private:
+    struct event {
+      const char* name;
+      int fd;
+    };
+    std::vector<event> events;
+
+#ifdef __linux__
+    static int open(std::uint32_t type,std::uint64_t config){
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      return int(syscall(SYS_perf_event_open,&attr,0,-1,-1,0));
+    }
+
+    void for_each_fd(unsigned long request){
+      for(auto& e : events){ ioctl(e.fd,request,0); }
+    }
+#endif
+
+  public:
+    perf_counters(): events{} {
+#ifdef __linux__
+      const std::array<std::pair<std::uint32_t,std::uint64_t>,names.size()> configs = {{
+	  {PERF_TYPE_HARDWARE,PERF_COUNT_HW_CPU_CYCLES},
+	  {PERF_TYPE_HARDWARE,PERF_COUNT_HW_INSTRUCTIONS},
+	  {PERF_TYPE_HW_CACHE,
+	   PERF_COUNT_HW_CACHE_L1D |
+	   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+	   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+	  {PERF_TYPE_HARDWARE,PERF_COUNT_HW_CACHE_MISSES},
+	  {PERF_TYPE_HARDWARE,PERF_COUNT_HW_BRANCH_MISSES},
+	  {PERF_TYPE_SOFTWARE,PERF_COUNT_SW_PAGE_FAULTS}
+	}};
+
+      for(auto i = 0ul; i < names.size(); ++i){
+	auto fd = open(configs[i].first,configs[i].second);
+	if(fd >= 0){ events.push_back(event{names[i],fd}); }
+      }
+#endif
+    }
+    perf_counters(const perf_counters&) = delete;
+    perf_counters(perf_counters&& other): events{std::move(other.events)} {
+      other.events.clear();
+    }
+    perf_counters& operator=(const perf_counters&) = delete;
+    perf_counters& operator=(perf_counters&&) = delete;
+    ~perf_counters(){
+#ifdef __linux__
+      for(auto& e : events){ close(e.fd); }
+#endif
+    }
+
+    bool available() const { return !events.empty(); }
+
+    // Reset and enable counting
+    void start(){
+#ifdef __linux__
+      for_each_fd(PERF_EVENT_IOC_RESET);
+      for_each_fd(PERF_EVENT_IOC_ENABLE);
+#endif
+    }
+
+    void stop(){
+#ifdef __linux__
+      for_each_fd(PERF_EVENT_IOC_DISABLE);
+#endif
+    }
+
+    // Counts since the last start(). Events never scheduled on the PMU are omitted.
+    std::vector<std::pair<std::string,double>> read() const {
+      auto counts = std::vector<std::pair<std::string,double>>{};
+#ifdef __linux__
+      for(auto& e : events){
+	std::uint64_t buffer[3]{}; // value, time_enabled, time_running
+	if(::read(e.fd,buffer,sizeof(buffer)) != sizeof(buffer) || !buffer[2]){ continue; }
+
+	auto scale = double(buffer[1]) / double(buffer[2]);
+	counts.emplace_back(e.name,double(buffer[0]) * scale);
+      }
+#endif
+      return counts;
+    }
+  };
+} // namespace ymd
+#endif // YMD_PERF_COUNTER_HH
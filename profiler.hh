@@ -0,0 +1,336 @@
+#ifndef YMD_PROFILER_HH
+#define YMD_PROFILER_HH 1
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+//  Requirement: c++2a (std::bit_width)
+//
+//  Macro      : YMD_PROFILE_SCOPE(name)
+//               Time the enclosing scope. Nested scopes form a call tree.
+//
+//               YMD_PROFILE_COUNTER(name,n)
+//               Add n to the named counter.
+//
+//               Both expand to nothing unless YMD_PROFILE is defined before
+//               including this header, so instrumentation can stay in the code.
+//               name must be a string literal (it is compared by address).
+//
+//  Function   : ymd::profile_report()      : Merged tree of all threads
+//               ymd::print_profile(os)     : Print the tree and the counters
+//               ymd::profile_counters()    : Merged counters
+//
+//               Each thread records into its own tree with relaxed atomics, so
+//               recording never takes a lock. Threads are registered (under a
+//               mutex) only on their first record. Per-call percentiles are
+//               approximated by a log-scale histogram (4 buckets per power of 2).
+//
+//  Usage       : void step(){
+//                  YMD_PROFILE_SCOPE("step");
+//                  {
+//                    YMD_PROFILE_SCOPE("load");
+//                    ...
+//                  }
+//                  YMD_PROFILE_COUNTER("samples",batch.size());
+//                }
+//
+//                ymd::print_profile(std::cout);
+//
+
+namespace ymd {
+  namespace detail {
+    inline constexpr std::size_t profile_buckets = 256;
+
+    inline std::size_t profile_bucket(std::uint64_t ns){
+      if(ns < 4){ return ns; }
+      auto msb = std::size_t(std::bit_width(ns)) - 1;
+      return 4*(msb - 1) + ((ns >> (msb - 2)) & 3);
+    }
+
+    // Representative (middle) value of a bucket
+    inline double profile_bucket_value(std::size_t i){
+      if(i < 4){ return double(i); }
+      auto msb = i/4 + 1;
+      auto width = std::uint64_t{1} << (msb - 2);
+      return double((4 + i%4) * width) + 0.5 * double(width);
+    }
+
+    // Only the owner thread writes, so relaxed load + store is enough.
+    inline void profile_add(std::atomic<std::uint64_t>& a,std::uint64_t v){
+      a.store(a.load(std::memory_order_relaxed) + v,std::memory_order_relaxed);
+    }
+
+    struct profile_node {
+      const char* name;
+      profile_node* parent;
+      std::atomic<profile_node*> child;
+      std::atomic<profile_node*> sibling;
+      std::atomic<std::uint64_t> count;
+      std::atomic<std::uint64_t> total_ns;
+      std::atomic<std::uint64_t> child_ns;
+      std::array<std::atomic<std::uint64_t>,profile_buckets> histogram;
+
+      profile_node(const char* name,profile_node* parent)
+	: name(name), parent(parent), child{nullptr}, sibling{nullptr},
+	  count{0}, total_ns{0}, child_ns{0}, histogram{} {}
+      profile_node(const profile_node&) = delete;
+      profile_node& operator=(const profile_node&) = delete;
+      ~profile_node(){
+	auto c = child.load(std::memory_order_relaxed);
+	while(c){
+	  auto next = c->sibling.load(std::memory_order_relaxed);
+	  delete c;
+	  c = next;
+	}
+      }
+    };
+
+    struct profile_counter_node {
+      const char* name;
+      std::atomic<std::uint64_t> value;
+      profile_counter_node* next;
+    };
+
+    class thread_profile {
+    private:
+      profile_node root;
+      profile_node* current;
+      std::atomic<profile_counter_node*> counters;
+
+    public:
+      thread_profile(): root{"",nullptr}, current{&root}, counters{nullptr} {}
+      thread_profile(const thread_profile&) = delete;
+      thread_profile& operator=(const thread_profile&) = delete;
+      ~thread_profile(){
+	auto c = counters.load(std::memory_order_relaxed);
+	while(c){
+	  auto next = c->next;
+	  delete c;
+	  c = next;
+	}
+      }
+
+      static auto& registry_mutex(){
+	static std::mutex m{};
+	return m;
+      }
+
+      static auto& registry(){
+	static std::vector<std::shared_ptr<thread_profile>> threads{};
+	return threads;
+      }
+
+      static thread_profile& get(){
+	thread_local auto self = [](){
+				   auto p = std::make_shared<thread_profile>();
+				   std::lock_guard<std::mutex> lock{registry_mutex()};
+				   registry().push_back(p);
+				   return p;
+				 }();
+	return *self;
+      }
+
+      const profile_node& tree() const { return root; }
+
+      profile_node* enter(const char* name){
+	auto node = current->child.load(std::memory_order_relaxed);
+	while(node && node->name != name){
+	  node = node->sibling.load(std::memory_order_relaxed);
+	}
+	if(!node){
+	  node = new profile_node{name,current};
+	  node->sibling.store(current->child.load(std::memory_order_relaxed),
+			      std::memory_order_relaxed);
+	  current->child.store(node,std::memory_order_release);
+	}
+	current = node;
+	return node;
+      }
+
+      void leave(profile_node* node,std::uint64_t ns){
+	profile_add(node->count,1);
+	profile_add(node->total_ns,ns);
+	profile_add(node->histogram[profile_bucket(ns)],1);
+	profile_add(node->parent->child_ns,ns);
+	current = node->parent;
+      }
+
+      void count(const char* name,std::uint64_t n){
+	auto c = counters.load(std::memory_order_relaxed);
+	while(c && c->name != name){ c = c->next; }
+	if(!c){
+	  c = new profile_counter_node{name,{0},counters.load(std::memory_order_relaxed)};
+	  counters.store(c,std::memory_order_release);
+	}
+	profile_add(c->value,n);
+      }
+
+      template<typename F> void for_each_counter(F&& f) const {
+	for(auto c = counters.load(std::memory_order_acquire); c; c = c->next){
+	  f(c->name,c->value.load(std::memory_order_relaxed));
+	}
+      }
+    };
+  } // namespace detail
+
+  class scope_timer {
+  private:
+    detail::thread_profile& profile;
+    detail::profile_node* node;
+    std::chrono::steady_clock::time_point start;
+
+  public:
+    explicit scope_timer(const char* name)
+      : profile{detail::thread_profile::get()}, node{profile.enter(name)},
+	start{std::chrono::steady_clock::now()} {}
+    scope_timer(const scope_timer&) = delete;
+    scope_timer& operator=(const scope_timer&) = delete;
+    ~scope_timer(){
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      profile.leave(node,std::uint64_t(ns));
+    }
+  };
+
+  inline void profile_count(const char* name,std::uint64_t n = 1){
+    detail::thread_profile::get().count(name,n);
+  }
+
+  struct profile_entry {
+    std::string name;
+    std::uint64_t count;
+    std::uint64_t total_ns;
+    std::uint64_t self_ns;
+    std::array<std::uint64_t,detail::profile_buckets> histogram;
+    std::vector<profile_entry> children;
+
+    // Approximate per-call time at quantile q (0 <= q <= 1)
+    double percentile(double q) const {
+      std::uint64_t n = 0;
+      for(auto h : histogram){ n += h; }
+      if(!n){ return 0.0; }
+
+      auto rank = std::max(std::uint64_t(q * n + 0.5),std::uint64_t{1});
+      std::uint64_t seen = 0;
+      for(auto i = 0ul; i < histogram.size(); ++i){
+	seen += histogram[i];
+	if(seen >= rank){ return detail::profile_bucket_value(i); }
+      }
+      return detail::profile_bucket_value(histogram.size() - 1);
+    }
+  };
+
+  namespace detail {
+    inline void merge_profile(profile_entry& entry,const profile_node& node){
+      entry.count += node.count.load(std::memory_order_relaxed);
+      entry.total_ns += node.total_ns.load(std::memory_order_relaxed);
+      auto child_ns = node.child_ns.load(std::memory_order_relaxed);
+      for(auto i = 0ul; i < profile_buckets; ++i){
+	entry.histogram[i] += node.histogram[i].load(std::memory_order_relaxed);
+      }
+
+      for(auto c = node.child.load(std::memory_order_acquire); c;
+	  c = c->sibling.load(std::memory_order_acquire)){
+	auto it = std::find_if(entry.children.begin(),entry.children.end(),
+			       [c](auto& e){ return e.name == c->name; });
+	if(it == entry.children.end()){
+	  entry.children.push_back(profile_entry{c->name,0,0,0,{},{}});
+	  it = std::prev(entry.children.end());
+	}
+	merge_profile(*it,*c);
+      }
+
+      // self_ns is accumulated, since the same path may come from many threads.
+      entry.self_ns += node.total_ns.load(std::memory_order_relaxed) -
+	std::min(child_ns,node.total_ns.load(std::memory_order_relaxed));
+    }
+
+    inline void print_profile(std::ostream& os,const profile_entry& e,std::size_t depth){
+      os << std::left << std::setw(32) << (std::string(2*depth,' ') + e.name)
+	 << std::right << std::setw(10) << e.count
+	 << std::setw(14) << std::fixed << std::setprecision(3) << e.total_ns * 1e-6
+	 << std::setw(14) << e.self_ns * 1e-6
+	 << std::setw(12) << std::setprecision(0) << e.percentile(0.5)
+	 << std::setw(12) << e.percentile(0.99) << "\n";
+      for(auto& c : e.children){ print_profile(os,c,depth+1); }
+    }
+  } // namespace detail
+
+  // Merged call tree of all threads. The root entry only holds children.
+  inline profile_entry profile_report(){
+    auto root = profile_entry{"",0,0,0,{},{}};
+
+    std::lock_guard<std::mutex> lock{detail::thread_profile::registry_mutex()};
+    for(auto& t : detail::thread_profile::registry()){
+      detail::merge_profile(root,t->tree());
+    }
+    root.self_ns = 0;
+
+    return root;
+  }
+
+  inline std::vector<std::pair<std::string,std::uint64_t>> profile_counters(){
+    auto counters = std::vector<std::pair<std::string,std::uint64_t>>{};
+
+    std::lock_guard<std::mutex> lock{detail::thread_profile::registry_mutex()};
+    for(auto& t : detail::thread_profile::registry()){
+      t->for_each_counter([&](const char* name,std::uint64_t value){
+			    auto it = std::find_if(counters.begin(),counters.end(),
+						   [name](auto& c){ return c.first == name; });
+			    if(it == counters.end()){
+			      counters.emplace_back(name,value);
+			    }else{
+			      it->second += value;
+			    }
+			  });
+    }
+
+    return counters;
+  }
+
+  // Formatted in a local stream, so that the flags of os are left untouched.
+  inline void print_profile(std::ostream& os){
+    std::ostringstream buffer{};
+    buffer << std::left << std::setw(32) << "scope"
+	   << std::right << std::setw(10) << "calls"
+	   << std::setw(14) << "total [ms]"
+	   << std::setw(14) << "self [ms]"
+	   << std::setw(12) << "p50 [ns]"
+	   << std::setw(12) << "p99 [ns]" << "\n";
+    for(auto& e : profile_report().children){ detail::print_profile(buffer,e,0); }
+
+    for(auto& [name,value] : profile_counters()){
+      buffer << std::left << std::setw(32) << name
+	     << std::right << std::setw(10) << value << "\n";
+    }
+
+    os << buffer.str();
+  }
+} // namespace ymd
+
+#define YMD_PROFILE_CONCAT_IMPL(a,b) a##b
+#define YMD_PROFILE_CONCAT(a,b) YMD_PROFILE_CONCAT_IMPL(a,b)
+
+#ifdef YMD_PROFILE
+#define YMD_PROFILE_SCOPE(name)						\
+  ::ymd::scope_timer YMD_PROFILE_CONCAT(ymd_profile_scope_,__LINE__){name}
+#define YMD_PROFILE_COUNTER(name,n) ::ymd::profile_count(name,n)
+#else
+#define YMD_PROFILE_SCOPE(name) static_cast<void>(0)
+#define YMD_PROFILE_COUNTER(name,n) static_cast<void>(0)
+#endif
+
+#endif // YMD_PROFILER_HH
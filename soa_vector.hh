@@ -0,0 +1,282 @@
+#ifndef YMD_SOA_VECTOR_HH
+#define YMD_SOA_VECTOR_HH 1
+
+#include <tuple>
+#include <memory>
+#include <new>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "zip.hh"
+#include "range_view.hh"
+
+//  Requirement: c++17 (aligned new, fold expression)
+//  Preferable : c++2a (structured bindings)
+//
+//  Class      : template<typename...Ts> class ymd::soa_vector
+//               Structure-of-arrays container. Each field Ts is stored in its own
+//               contiguous column aligned to soa_vector::alignment bytes, while all
+//               columns share a single size and capacity.
+//
+//               Member
+//               ------
+//               push_back(const Ts&...) / emplace_back(Args&&...) : Append a row
+//                                                   (one argument per column).
+//               data<N>()   : Pointer to the N-th column (for SIMD loops).
+//               column<N>() : range_view over the N-th column.
+//               operator[]  : Tuple of references to the i-th row.
+//               begin/end   : Row iterators (same as ymd::zip over all columns).
+//
+//  Usage       : ymd::soa_vector<double,double,int> s{};
+//                s.push_back(1.0,2.0,3);
+//
+//                for(auto&& [x,y,id] : s){ ... }
+//                for(auto&& [x,y] : ymd::zip(s.column<0>(),s.column<1>())){ ... }
+//
+
+namespace ymd {
+  template<typename...Ts> class soa_vector {
+  public:
+    using size_type = std::size_t;
+    using iterator = detail::zip_iterator<Ts*...>;
+    using const_iterator = detail::zip_iterator<const Ts*...>;
+
+    static constexpr std::size_t alignment = 64;
+
+  private:
+    std::tuple<Ts*...> columns;
+    size_type n;
+    size_type cap;
+
+    template<typename T> static constexpr std::align_val_t align_of(){
+      return std::align_val_t{std::max(alignment,alignof(T))};
+    }
+
+    template<typename T> static T* allocate(size_type count){
+      if(!count){ return nullptr; }
+      return static_cast<T*>(::operator new(count * sizeof(T),align_of<T>()));
+    }
+
+    template<typename T> static void deallocate(T* p){
+      if(p){ ::operator delete(p,align_of<T>()); }
+    }
+
+    // Uninitialized columns, deallocated unless taken by release()
+    struct raw_columns {
+      std::tuple<Ts*...> p;
+
+      raw_columns(): p{} {}
+      raw_columns(const raw_columns&) = delete;
+      raw_columns& operator=(const raw_columns&) = delete;
+      ~raw_columns(){ std::apply([](auto*...q){ (deallocate(q),...); },p); }
+
+      template<std::size_t...Ns>
+      void allocate(size_type count,std::index_sequence<Ns...>){
+	((std::get<Ns>(p) = soa_vector::allocate<Ts>(count)),...);
+      }
+      std::tuple<Ts*...> release(){ return std::exchange(p,std::tuple<Ts*...>{}); }
+    };
+
+    void destroy(){
+      std::apply([this](auto*...p){ (std::destroy_n(p,n),...); },columns);
+    }
+
+    void release(){
+      destroy();
+      std::apply([](auto*...p){ (deallocate(p),...); },columns);
+    }
+
+    // Move (or copy, when moving may throw) count elements of a column.
+    template<bool Copy,typename T> static void transfer(T* src,size_type count,T* dst){
+      if constexpr (!Copy && (std::is_nothrow_move_constructible_v<T> ||
+			      !std::is_copy_constructible_v<T>)){
+	std::uninitialized_move_n(src,count,dst);
+      }else{
+	std::uninitialized_copy_n(src,count,dst);
+      }
+    }
+
+    // Construct the first count rows of dst from src. If a column throws, the
+    // columns already built are destroyed.
+    template<bool Copy,std::size_t...Ns>
+    static void construct_columns(const std::tuple<Ts*...>& dst,
+				  const std::tuple<Ts*...>& src,size_type count,
+				  std::index_sequence<Ns...>){
+      std::size_t built = 0;
+      try {
+	((transfer<Copy>(std::get<Ns>(src),count,std::get<Ns>(dst)), ++built),...);
+      }catch(...){
+	((Ns < built ? void(std::destroy_n(std::get<Ns>(dst),count)) : void()),...);
+	throw;
+      }
+    }
+
+    // Construct the i-th row of dst from one argument per column. If a column
+    // throws, the elements already built in this row are destroyed.
+    template<typename...Args,std::size_t...Ns>
+    static void construct_row(const std::tuple<Ts*...>& dst,size_type i,
+			      std::index_sequence<Ns...>,Args&&...args){
+      std::size_t built = 0;
+      try {
+	((::new(static_cast<void*>(std::get<Ns>(dst) + i)) Ts(std::forward<Args>(args)),
+	  ++built),...);
+      }catch(...){
+	((Ns < built ? std::destroy_at(std::get<Ns>(dst) + i) : void()),...);
+	throw;
+      }
+    }
+
+    // Replace the columns by the fully constructed fresh ones.
+    void adopt(raw_columns& fresh,size_type new_cap){
+      release();
+      columns = fresh.release();
+      cap = new_cap;
+    }
+
+    // Value-initialize rows [n, count) of every column.
+    template<std::size_t...Ns>
+    void value_construct(size_type count,std::index_sequence<Ns...>){
+      std::size_t built = 0;
+      try {
+	((std::uninitialized_value_construct(std::get<Ns>(columns) + n,
+					     std::get<Ns>(columns) + count),
+	  ++built),...);
+      }catch(...){
+	((Ns < built ?
+	  std::destroy(std::get<Ns>(columns) + n,std::get<Ns>(columns) + count) :
+	  void()),...);
+	throw;
+      }
+    }
+
+    // Nothing changes if allocating or copying throws.
+    void reallocate(size_type new_cap){
+      raw_columns fresh{};
+      fresh.allocate(new_cap,std::index_sequence_for<Ts...>{});
+      construct_columns<false>(fresh.p,columns,n,std::index_sequence_for<Ts...>{});
+      adopt(fresh,new_cap);
+    }
+
+  public:
+    soa_vector(): columns{}, n{0}, cap{0} {}
+    soa_vector(const soa_vector& other): columns{}, n{0}, cap{0} {
+      raw_columns fresh{};
+      fresh.allocate(other.n,std::index_sequence_for<Ts...>{});
+      construct_columns<true>(fresh.p,other.columns,other.n,
+			      std::index_sequence_for<Ts...>{});
+      adopt(fresh,other.n);
+      n = other.n;
+    }
+    soa_vector(soa_vector&& other) noexcept
+      : columns{std::exchange(other.columns,std::tuple<Ts*...>{})},
+	n{std::exchange(other.n,0)}, cap{std::exchange(other.cap,0)} {}
+    explicit soa_vector(size_type count): soa_vector() { resize(count); }
+    soa_vector& operator=(const soa_vector& other){
+      if(this != &other){ soa_vector copy{other}; swap(copy); }
+      return *this;
+    }
+    soa_vector& operator=(soa_vector&& other) noexcept {
+      soa_vector moved{std::move(other)};
+      swap(moved);
+      return *this;
+    }
+    ~soa_vector(){ release(); }
+
+    size_type size() const { return n; }
+    size_type capacity() const { return cap; }
+    bool empty() const { return n == 0; }
+
+    void reserve(size_type new_cap){
+      if(new_cap > cap){ reallocate(new_cap); }
+    }
+
+    void resize(size_type count){
+      if(count < n){
+	std::apply([this,count](auto*...p){ (std::destroy(p + count,p + n),...); },
+		   columns);
+      }else if(count > n){
+	reserve(count);
+	value_construct(count,std::index_sequence_for<Ts...>{});
+      }
+      n = count;
+    }
+
+    void clear(){
+      destroy();
+      n = 0;
+    }
+
+    // args may refer to existing rows: on growth the new row is built in the new
+    // columns before the old rows are moved and freed.
+    template<typename...Args> auto emplace_back(Args&&...args){
+      static_assert(sizeof...(Args) == sizeof...(Ts),
+		    "soa_vector::emplace_back takes one argument per column");
+      constexpr auto indices = std::index_sequence_for<Ts...>{};
+
+      if(n == cap){
+	auto new_cap = cap ? 2*cap : 1;
+	raw_columns fresh{};
+	fresh.allocate(new_cap,indices);
+	construct_row(fresh.p,n,indices,std::forward<Args>(args)...);
+	try {
+	  construct_columns<false>(fresh.p,columns,n,indices);
+	}catch(...){
+	  std::apply([this](auto*...p){ (std::destroy_at(p + n),...); },fresh.p);
+	  throw;
+	}
+	adopt(fresh,new_cap);
+      }else{
+	construct_row(columns,n,indices,std::forward<Args>(args)...);
+      }
+
+      ++n;
+      return (*this)[n-1];
+    }
+    void push_back(const Ts&...values){ emplace_back(values...); }
+    void push_back(Ts&&...values){ emplace_back(std::move(values)...); }
+
+    void pop_back(){
+      --n;
+      std::apply([this](auto*...p){ (std::destroy_at(p + n),...); },columns);
+    }
+
+    // Remove the pos-th row, keeping the order of the remaining rows.
+    void erase(size_type pos){
+      std::apply([this,pos](auto*...p){ (std::move(p + pos + 1,p + n,p + pos),...); },
+		 columns);
+      pop_back();
+    }
+
+    void swap(soa_vector& other) noexcept {
+      std::swap(columns,other.columns);
+      std::swap(n,other.n);
+      std::swap(cap,other.cap);
+    }
+    friend inline void swap(soa_vector& lhs,soa_vector& rhs) noexcept { lhs.swap(rhs); }
+
+    template<std::size_t N> auto data(){ return std::get<N>(columns); }
+    template<std::size_t N> auto data() const {
+      return static_cast<const std::tuple_element_t<N,std::tuple<Ts...>>*>(
+	std::get<N>(columns));
+    }
+
+    template<std::size_t N> auto column(){
+      return range_view{data<N>(),data<N>() + n};
+    }
+    template<std::size_t N> auto column() const {
+      return range_view{data<N>(),data<N>() + n};
+    }
+
+    auto begin(){ return iterator{columns}; }
+    auto   end(){ return begin() + n; }
+    auto begin() const { return const_iterator{std::tuple<const Ts*...>{columns}}; }
+    auto   end() const { return begin() + n; }
+
+    auto operator[](size_type i){ return begin()[i]; }
+    auto operator[](size_type i) const { return begin()[i]; }
+  };
+
+} // namespace ymd
+#endif // YMD_SOA_VECTOR_HH
@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <chrono>
+#include <type_traits>
+#include <atomic>
 
 // Requirement: c++17 (std::chorno::floor)
 //
@@ -14,26 +16,66 @@
 //
 //              Return
 //              ------
-//              void
+//              std::chrono::nanoseconds: Elapsed time of N iterations
 //
 // Usage       : ymd::time_N([](){ return 1 + 3; },1000);
 //
+// Function   : template<typename T> void do_not_optimize(T&& value)
+//              void clobber_memory()
+//              Compiler barriers. do_not_optimize forces value to be computed,
+//              clobber_memory forces pending writes to memory.
+//
+// Usage       : ymd::do_not_optimize(v.data()); f(v); ymd::clobber_memory();
+//
 
 namespace ymd {
 
+#if defined(__GNUC__) || defined(__clang__)
+  template<typename T> inline void do_not_optimize(T&& value){
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  inline void clobber_memory(){
+    asm volatile("" : : : "memory");
+  }
+#else
+  template<typename T> inline void do_not_optimize(T&& value){
+    const volatile auto* p = &reinterpret_cast<const volatile char&>(value);
+    (void)*p;
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+  }
+
+  inline void clobber_memory(){
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+  }
+#endif
+
+  namespace detail {
+    // Call f and keep its return value (if any) alive.
+    template<typename F> inline void invoke_kept(F& f){
+      if constexpr (std::is_void_v<decltype(f())>){
+	f();
+	clobber_memory();
+      }else{
+	auto&& r = f();
+	do_not_optimize(r);
+      }
+    }
+  } // namespace detail
+
   template<typename F>
   inline auto time_N(F f,std::size_t N){
     using namespace std::chrono;
 
-    auto start = system_clock::now();
+    auto start = steady_clock::now();
 
     for(auto i = 0ul; i < N; ++i){
-      f();
+      detail::invoke_kept(f);
     }
 
-    auto end = system_clock::now();
+    auto end = steady_clock::now();
 
-    auto elapsed = end - start;
+    auto elapsed = duration_cast<nanoseconds>(end - start);
     std::cout << floor<hours>(elapsed).count() << "h "
 	      << floor<minutes>(elapsed).count() % 60 << "min "
 	      << floor<seconds>(elapsed).count() % 60 << "s "
@@ -41,6 +83,8 @@ namespace ymd {
 	      << floor<microseconds>(elapsed).count() % 1000 << "us "
 	      << floor<nanoseconds>(elapsed).count() % 1000 << "ns"
 	      << std::endl;
+
+    return elapsed;
   }
 }
 #endif // YMD_TIMER_HH
@@ -13,7 +13,7 @@ namespace ymd {
   public:
     using iterator_category = std::input_iterator_tag;
     using difference_type = ptrdiff_t;
-    using value_type = decltype(f(std::declval<typename Iterator::value_type>()));
+    using value_type = std::decay_t<decltype(f(*std::declval<Iterator&>()))>;
     using pointer = value_type*;
     using reference = value_type&;
 
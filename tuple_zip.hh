@@ -2,24 +2,54 @@
 #define YMD_TUPLE_ZIP_HH 1
 
 #include <tuple>
+#include <array>
 #include <algorithm>
+#include <cmath>
+#include <functional>
+#include <type_traits>
 #include <utility>
 
+//  Requirement: c++17 (constexpr lambda, if constexpr)
+//
+//  Fixed size vector kernels over std::array and/or std::tuple. The size is known
+//  at compile time, so every function is fully unrolled through
+//  std::index_sequence and usable in constexpr context.
+//
+//  Function   : zip_for_each(f,t...) : std::tuple{f(get<0>(t)...), f(get<1>(t)...), ...}
+//               zip_map(f,t,u...)    : Same as zip_for_each, but returns std::array
+//                                      when t is std::array.
+//               add/sub/mul/div(a,b) : Element-wise arithmetic
+//               scale(a,s)           : a * s for each element
+//               fma(a,b,c)           : a * b + c for each element. Floating point
+//                                      elements are rounded once (std::fma) at run
+//                                      time with c++20; std::fma is not constexpr
+//                                      before c++23, so constant evaluation rounds
+//                                      twice.
+//               reduce(f,t[,init])   : f(...f(f(init,get<0>(t)),get<1>(t))...)
+//               sum/hmin/hmax(t)     : Horizontal sum/min/max
+//               dot(a,b)             : Inner product
+//
+//  Usage       : constexpr auto a = std::array{1.0,2.0,3.0};
+//                constexpr auto b = std::array{4.0,5.0,6.0};
+//                static_assert(ymd::dot(a,b) == 32.0);
+//                static_assert(ymd::hmax(ymd::fma(a,b,a)) == 21.0);
+//
+
 namespace ymd {
   template<std::size_t N,typename F,typename...Tuples>
-  inline auto apply_at_N(F&& f,Tuples&&...tuples){
+  constexpr inline auto apply_at_N(F&& f,Tuples&&...tuples){
     return f(std::get<N>(tuples)...);
   }
 
   template<std::size_t...Ns>
-  inline auto get(const std::index_sequence<Ns...>&){
+  constexpr inline auto get(const std::index_sequence<Ns...>&){
     return [=](auto&& f,auto&...t){
 	     return std::make_tuple(apply_at_N<Ns>(f,t...)...);
 	   };
 
   }
 
-  template<typename F,typename...Tuples> inline auto
+  template<typename F,typename...Tuples> constexpr inline auto
   zip_for_each(F&& f,Tuples&...tuples){
     using indices_t =
       std::make_index_sequence<std::min({std::tuple_size<Tuples>::value...})>;
@@ -27,5 +57,133 @@ namespace ymd {
     return get(indices_t{})(f,tuples...);
   }
 
+  namespace detail {
+    template<typename X,typename Y,typename Z>
+    constexpr inline auto fused_multiply_add(const X& x,const Y& y,const Z& z){
+#ifdef __cpp_lib_is_constant_evaluated
+      if constexpr(std::is_floating_point_v<X> &&
+		   std::is_floating_point_v<Y> &&
+		   std::is_floating_point_v<Z>){
+	if(!std::is_constant_evaluated()){ return std::fma(x,y,z); }
+      }
+#endif
+      return x * y + z;
+    }
+
+    template<typename T,typename = void> struct is_tuple_like : std::false_type {};
+    template<typename T>
+    struct is_tuple_like<T,std::void_t<decltype(std::tuple_size<T>::value)>>
+      : std::true_type {};
+
+    // Restrict the kernels below to std::tuple_size aware types, so that
+    // e.g. an unqualified fma(x,y,z) on scalars never matches them.
+    template<typename...Ts>
+    inline constexpr bool are_tuple_like_v = (is_tuple_like<Ts>::value && ...);
+
+    template<typename...Ts>
+    using enable_if_tuple_like_t = std::enable_if_t<are_tuple_like_v<Ts...>,std::nullptr_t>;
+
+    template<typename T> struct is_std_array : std::false_type {};
+    template<typename T,std::size_t N>
+    struct is_std_array<std::array<T,N>> : std::true_type {};
+
+    template<typename T,typename...Tuples>
+    constexpr inline std::size_t min_size(){
+      return std::min({std::tuple_size<T>::value,std::tuple_size<Tuples>::value...});
+    }
+
+    template<typename T,typename F,typename...Tuples,std::size_t...Ns>
+    constexpr inline auto zip_map(std::index_sequence<Ns...>,F&& f,
+				  const T& t,const Tuples&...tuples){
+      if constexpr (is_std_array<T>::value){
+	using value_type =
+	  std::common_type_t<decltype(apply_at_N<Ns>(f,t,tuples...))...>;
+	return std::array<value_type,sizeof...(Ns)>{apply_at_N<Ns>(f,t,tuples...)...};
+      }else{
+	return std::make_tuple(apply_at_N<Ns>(f,t,tuples...)...);
+      }
+    }
+
+    template<std::size_t I,std::size_t N,typename F,typename Acc,typename T>
+    constexpr inline auto reduce(F&& f,Acc&& acc,const T& t){
+      if constexpr (I == N){
+	return acc;
+      }else{
+	return detail::reduce<I+1,N>(f,f(std::forward<Acc>(acc),std::get<I>(t)),t);
+      }
+    }
+  } // namespace detail
+
+  template<typename F,typename T,typename...Tuples,
+	   detail::enable_if_tuple_like_t<T,Tuples...> = nullptr>
+  constexpr inline auto zip_map(F&& f,const T& t,const Tuples&...tuples){
+    using indices_t = std::make_index_sequence<detail::min_size<T,Tuples...>()>;
+
+    return detail::zip_map(indices_t{},std::forward<F>(f),t,tuples...);
+  }
+
+  template<typename T,typename U,detail::enable_if_tuple_like_t<T,U> = nullptr>
+  constexpr inline auto add(const T& a,const U& b){
+    return zip_map(std::plus<>{},a,b);
+  }
+  template<typename T,typename U,detail::enable_if_tuple_like_t<T,U> = nullptr>
+  constexpr inline auto sub(const T& a,const U& b){
+    return zip_map(std::minus<>{},a,b);
+  }
+  template<typename T,typename U,detail::enable_if_tuple_like_t<T,U> = nullptr>
+  constexpr inline auto mul(const T& a,const U& b){
+    return zip_map(std::multiplies<>{},a,b);
+  }
+  template<typename T,typename U,detail::enable_if_tuple_like_t<T,U> = nullptr>
+  constexpr inline auto div(const T& a,const U& b){
+    return zip_map(std::divides<>{},a,b);
+  }
+
+  template<typename T,typename S,detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto scale(const T& a,const S& s){
+    return zip_map([&s](const auto& v){ return v * s; },a);
+  }
+
+  template<typename T,typename U,typename V,
+	   detail::enable_if_tuple_like_t<T,U,V> = nullptr>
+  constexpr inline auto fma(const T& a,const U& b,const V& c){
+    return zip_map([](const auto& x,const auto& y,const auto& z){
+		     return detail::fused_multiply_add(x,y,z);
+		   },a,b,c);
+  }
+
+  template<typename F,typename T,typename Init,
+	   detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto reduce(F&& f,const T& t,Init&& init){
+    return detail::reduce<0,std::tuple_size<T>::value>(f,std::forward<Init>(init),t);
+  }
+
+  template<typename F,typename T,detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto reduce(F&& f,const T& t){
+    static_assert(std::tuple_size<T>::value > 0,
+		  "ymd::reduce without init requires at least one element");
+    return detail::reduce<1,std::tuple_size<T>::value>(f,std::get<0>(t),t);
+  }
+
+  template<typename T,detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto sum(const T& t){
+    return ymd::reduce(std::plus<>{},t);
+  }
+
+  template<typename T,detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto hmin(const T& t){
+    return ymd::reduce([](const auto& a,const auto& b){ return (b < a) ? b : a; },t);
+  }
+
+  template<typename T,detail::enable_if_tuple_like_t<T> = nullptr>
+  constexpr inline auto hmax(const T& t){
+    return ymd::reduce([](const auto& a,const auto& b){ return (a < b) ? b : a; },t);
+  }
+
+  template<typename T,typename U,detail::enable_if_tuple_like_t<T,U> = nullptr>
+  constexpr inline auto dot(const T& a,const U& b){
+    return ymd::sum(ymd::mul(a,b));
+  }
+
 } // namespace ymd
 #endif // YMD_TUPLE_ZIP_HH
@@ -5,6 +5,8 @@
 #include <tuple>
 #include <algorithm>
 #include <type_traits>
+#include <utility>
+#include <cstddef>
 
 //  Requirement: c++17 (std::apply)
 //  Preferable : c++2a (structured bindings)
@@ -23,19 +25,81 @@
 //                   ...
 //                }
 //
+//                When all of v are random access, so is the zipped iterator, and
+//                the zipped range can be sorted (or passed to parallel algorithms)
+//                in place;
+//
+//                auto z = ymd::zip(keys,values);
+//                std::sort(z.begin(),z.end(),
+//                          [](auto&& a,auto&& b){ return std::get<0>(a) < std::get<0>(b); });
+//
 
 namespace ymd {
   namespace detail {
+    // Proxy returned by zip_iterator::operator*. It behaves as a tuple of
+    // references, but assignment always writes through to the referred elements
+    // and swap exchanges them, so that algorithms like std::sort can permute them.
+    template<typename...Refs> class zip_reference : public std::tuple<Refs...> {
+    private:
+      using base_type = std::tuple<Refs...>;
+
+      template<typename Tuple,std::size_t...Ns>
+      void assign(Tuple&& t,std::index_sequence<Ns...>){
+	[](auto&&...){}((std::get<Ns>(*this) = std::get<Ns>(std::forward<Tuple>(t)))...);
+      }
+
+      template<std::size_t...Ns>
+      static void swap_elements(zip_reference& lhs,zip_reference& rhs,
+				std::index_sequence<Ns...>){
+	using std::swap;
+	[](auto&&...){}((swap(std::get<Ns>(lhs),std::get<Ns>(rhs)),0)...);
+      }
+
+    public:
+      zip_reference() = delete;
+      zip_reference(const zip_reference&) = default;
+      zip_reference(zip_reference&&) = default;
+      explicit zip_reference(Refs...refs): base_type(std::forward<Refs>(refs)...) {}
+      ~zip_reference() = default;
+
+      // Copy through (never move), since *it = *other must not steal from other.
+      zip_reference& operator=(const zip_reference& other){
+	assign(static_cast<const base_type&>(other),
+	       std::index_sequence_for<Refs...>{});
+	return *this;
+      }
+      zip_reference& operator=(zip_reference&& other){
+	return *this = static_cast<const zip_reference&>(other);
+      }
+      template<typename...Values>
+      zip_reference& operator=(const std::tuple<Values...>& t){
+	assign(t,std::index_sequence_for<Refs...>{});
+	return *this;
+      }
+      template<typename...Values>
+      zip_reference& operator=(std::tuple<Values...>&& t){
+	assign(std::move(t),std::index_sequence_for<Refs...>{});
+	return *this;
+      }
+
+      // Taken by value so that both *it (prvalue) and named proxies are swapped
+      // element-wise instead of by the generic std::swap.
+      friend inline void swap(zip_reference lhs,zip_reference rhs){
+	swap_elements(lhs,rhs,std::index_sequence_for<Refs...>{});
+      }
+    };
+
     template<typename...Types> class zip_iterator {
     private:
       std::tuple<Types...> iterator;
 
     public:
-      using iterator_category = std::input_iterator_tag;
+      using iterator_category =
+	std::common_type_t<typename std::iterator_traits<Types>::iterator_category...>;
       using difference_type = ptrdiff_t;
-      using value_type = decltype(std::tie((*std::declval<Types>())...));
-      using pointer = std::add_pointer_t<value_type>;
-      using reference = std::add_lvalue_reference_t<value_type>;
+      using value_type = std::tuple<typename std::iterator_traits<Types>::value_type...>;
+      using reference = zip_reference<decltype(*std::declval<Types>())...>;
+      using pointer = std::add_pointer_t<reference>;
 
       zip_iterator() = default;
       zip_iterator(const zip_iterator&) = default;
@@ -56,8 +120,30 @@ namespace ymd {
       }
       auto operator--(int){ auto copy{*this}; --(*this); return copy; }
 
-      auto operator*(){
-	return std::apply([](auto&&...v){ return std::tie((*v)...); },iterator);
+      // Random access (only instantiated when all Types are random access)
+      auto& operator+=(difference_type n){
+	std::apply([n](auto&&...v){ [](auto&&...v){}((v += n)...); },iterator);
+	return *this;
+      }
+      auto& operator-=(difference_type n){ return *this += -n; }
+      auto operator[](difference_type n) const { return *(*this + n); }
+
+      auto operator*() const {
+	return std::apply([](auto&&...v){ return reference{(*v)...}; },iterator);
+      }
+
+      friend inline auto operator+(zip_iterator<Types...> it,difference_type n){
+	return it += n;
+      }
+      friend inline auto operator+(difference_type n,zip_iterator<Types...> it){
+	return it += n;
+      }
+      friend inline auto operator-(zip_iterator<Types...> it,difference_type n){
+	return it -= n;
+      }
+      friend inline difference_type operator-(const zip_iterator<Types...>& lhs,
+					      const zip_iterator<Types...>& rhs){
+	return std::get<0>(lhs.iterator) - std::get<0>(rhs.iterator);
       }
 
       friend inline auto operator<(const zip_iterator<Types...>& lhs,
@@ -100,8 +186,11 @@ namespace ymd {
       zip& operator=(zip&&) = default;
       ~zip() = default;
 
-      auto begin(){ return zip_iterator<Types...>{begins}; }
-      auto   end(){ return zip_iterator<Types...>{  ends}; }
+      auto begin() const { return zip_iterator<Types...>{begins}; }
+      auto   end() const { return zip_iterator<Types...>{  ends}; }
+      std::size_t size() const {
+	return std::distance(std::get<0>(begins),std::get<0>(ends));
+      }
     };
 
     template<typename T> inline auto begin(T&& t){ t.begin(); }
@@ -118,4 +207,15 @@ namespace ymd {
     return zip_t{std::make_tuple(begin(v)...),std::make_tuple((begin(v)+min)...)};
   }
 } // namespace ymd
+
+namespace std {
+  // Structured bindings and std::apply on *zip_iterator
+  template<typename...Refs>
+  struct tuple_size<ymd::detail::zip_reference<Refs...>>
+    : tuple_size<tuple<Refs...>> {};
+
+  template<size_t N,typename...Refs>
+  struct tuple_element<N,ymd::detail::zip_reference<Refs...>>
+    : tuple_element<N,tuple<Refs...>> {};
+} // namespace std
 #endif // YMD_ZIP_HH